@@ -62,6 +62,110 @@ int cmd_do_version(int argc, char** argv, cmd_line_desc_ptr_t cmd_line_desc) {
   return CMD_LINE_SUCCESS;
 }
 
+#if CMD_LINE_MAX_JOBS > 0
+/* Jobs can be managed only from the command line itself. Returns 1 and prints error in a background job. */
+int cmd_refuse_in_job(cmd_line_desc_ptr_t cmd_line_desc) {
+  if (cmd_line_is_job(cmd_line_desc)) {
+      cmd_line_printf_tk(cmd_line_desc, "Not available in a background job.\r\n");
+      return 1;
+  }
+  return 0;
+}
+
+int cmd_do_jobs(int argc, char** argv, cmd_line_desc_ptr_t cmd_line_desc) {
+  if (cmd_refuse_in_job(cmd_line_desc)) {
+      return CMD_LINE_ERR_GENERAL;
+  }
+
+  int job_id;
+  for (job_id = 1; job_id <= CMD_LINE_MAX_JOBS; job_id++) {
+      int state = cmd_line_job_state(cmd_line_desc, job_id);
+      if (state != CMD_LINE_JOB_FREE) {
+          cmd_line_printf_tk(cmd_line_desc, "[%d] %s %s\r\n", job_id,
+                             state == CMD_LINE_JOB_RUNNING ? "Running" : "Done",
+                             cmd_line_job_name(cmd_line_desc, job_id));
+      }
+  }
+
+  return CMD_LINE_SUCCESS;
+}
+
+/* Returns the job identifier, or 0 if the argument is not a valid one. */
+int cmd_parse_job_id(const char* arg) {
+  char* end;
+  long job_id = strtol(arg, &end, 10);
+  if (end == arg || *end != '\0' || job_id < 1 || job_id > CMD_LINE_MAX_JOBS) {
+      return 0;
+  }
+  return (int)job_id;
+}
+
+int cmd_wait_for_job(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  int ret_val = cmd_line_job_wait(cmd_line_desc, job_id);
+  if (ret_val == CMD_LINE_ERR_TIMEOUT) {
+      cmd_line_printf_tk(cmd_line_desc, "Waiting timed out.\r\n");
+  }
+  else if (ret_val == CMD_LINE_ERR_INTERRUPTED) {
+      cmd_line_printf_tk(cmd_line_desc, "Waiting interrupted.\r\n");
+  }
+  return ret_val;
+}
+
+int cmd_do_wait(int argc, char** argv, cmd_line_desc_ptr_t cmd_line_desc) {
+  if (cmd_refuse_in_job(cmd_line_desc)) {
+      return CMD_LINE_ERR_GENERAL;
+  }
+
+  int ret_val = CMD_LINE_SUCCESS;
+  if (argc > 0) {
+      int argi;
+      for (argi = 1; argi < argc+1; argi++) {
+          int job_id = cmd_parse_job_id(argv[argi]);
+          if (job_id == 0) {
+              cmd_line_printf_tk(cmd_line_desc, "Invalid job %s.\r\n", argv[argi]);
+              ret_val = CMD_LINE_ERR_PARSE;
+              continue;
+          }
+          int wait_ret_val = cmd_wait_for_job(cmd_line_desc, job_id);
+          if (wait_ret_val != CMD_LINE_SUCCESS) {
+              return wait_ret_val;
+          }
+      }
+  }
+  else {
+      ret_val = cmd_wait_for_job(cmd_line_desc, 0);
+  }
+
+  return ret_val;
+}
+
+int cmd_do_kill(int argc, char** argv, cmd_line_desc_ptr_t cmd_line_desc) {
+  if (cmd_refuse_in_job(cmd_line_desc)) {
+      return CMD_LINE_ERR_GENERAL;
+  }
+
+  if (argc == 0) {
+      cmd_line_printf_tk(cmd_line_desc, "Job id expected.\r\n");
+      return CMD_LINE_ERR_PARSE;
+  }
+
+  int ret_val = CMD_LINE_SUCCESS;
+  int argi;
+  for (argi = 1; argi < argc+1; argi++) {
+      int job_id = cmd_parse_job_id(argv[argi]);
+      if (job_id == 0) {
+          cmd_line_printf_tk(cmd_line_desc, "Invalid job %s.\r\n", argv[argi]);
+          ret_val = CMD_LINE_ERR_PARSE;
+      }
+      else if (cmd_line_job_kill(cmd_line_desc, job_id) != CMD_LINE_SUCCESS) {
+          cmd_line_printf_tk(cmd_line_desc, "No running job %s.\r\n", argv[argi]);
+      }
+  }
+
+  return ret_val;
+}
+#endif
+
 cmd_desc_t cmd_desc_help =
     {
         .name = "help",
@@ -90,9 +194,67 @@ cmd_desc_t cmd_desc_version =
         .cmd_fcn = &cmd_do_version
     };
 
+#if CMD_LINE_MAX_JOBS > 0
+cmd_desc_t cmd_desc_jobs =
+    {
+        .name = "jobs",
+        .one_line = "Prints the list of background jobs.",
+        .description = "jobs\r\n"
+            "Prints the list of background jobs with their state.\r\n"
+            "A command runs in background when the line ends with '&'.\r\n"
+            "\r\n"
+            "Example:\r\n"
+            "\t--> version &\r\n"
+            "\t[1] version\r\n"
+            "\t--> jobs\r\n"
+            "\t[1] Running version\r\n",
+        .cmd_fcn = &cmd_do_jobs
+    };
+
+cmd_desc_t cmd_desc_wait =
+    {
+        .name = "wait",
+        .one_line = "Waits for background jobs to finish.",
+        .description = "wait [job]\r\n"
+            "Waits for all background jobs, or for the jobs given as parameters,\r\n"
+            "to finish and prints their output.\r\n"
+            "Stops waiting when any key is pressed or when the wait times out.\r\n"
+            "\r\n"
+            "Example:\r\n"
+            "\t--> wait 1\r\n"
+            "\tFirmware version: 1.0a\r\n"
+            "\t[1] Done (0) version\r\n",
+        .cmd_fcn = &cmd_do_wait
+    };
+
+cmd_desc_t cmd_desc_kill =
+    {
+        .name = "kill",
+        .one_line = "Requests a background job to stop.",
+        .description = "kill job\r\n"
+            "Requests the background jobs given as parameters to stop.\r\n"
+            "The command stops once it checks the request, its status\r\n"
+            "is printed when it finishes.\r\n"
+            "\r\n"
+            "Example:\r\n"
+            "\t--> selftest &\r\n"
+            "\t[1] selftest\r\n"
+            "\t--> kill 1\r\n"
+            "\t-->\r\n"
+            "\t(later, when selftest stops)\r\n"
+            "\t[1] Killed (8) selftest\r\n",
+        .cmd_fcn = &cmd_do_kill
+    };
+#endif
+
 const cmd_desc_t* basic_cmd_list[] =
   {
       &cmd_desc_help,
       &cmd_desc_version,
+#if CMD_LINE_MAX_JOBS > 0
+      &cmd_desc_jobs,
+      &cmd_desc_wait,
+      &cmd_desc_kill,
+#endif
       NULL
   };
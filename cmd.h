@@ -18,6 +18,7 @@
  * The basic commands are:
  * * help - to print the list of all commands
  * * version - to print the firmware version string. @see cmd_line_fw_version
+ * * jobs, wait, kill - to list, wait for and stop background jobs.
  *
  *  Created on: 20. 7. 2017
  *  Author: Michal Horn
@@ -34,6 +35,9 @@
  * The basic commands are:
  * * help - to print list of all commands and/or their detailed description.
  * * version - to print he firmware version. @see cmd_line_fw_version.
+ * * jobs - to print the list of background jobs.
+ * * wait - to wait for background jobs to finish.
+ * * kill - to request a background job to stop.
  *
  * Use this with @ref CMD_LINE_INCLUDE_SUBLIST to include as a sublist.
  */
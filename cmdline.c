@@ -10,6 +10,10 @@
 #include <string.h>
 #include <ctype.h>
 
+#if CMD_LINE_MAX_JOBS > 0
+struct cmd_line_job;
+#endif
+
 /**
  * Definition of command line instance descriptor.
  *
@@ -38,14 +42,44 @@ struct cmd_line_desc {
   int max_args;
   char echo_enabled;
   const cmd_desc_t** cmd_line_root_list;
+#if CMD_LINE_MAX_JOBS > 0
+  job_spawn_t job_spawn;
+  struct cmd_line_job* jobs;  /* Job slots of this instance, NULL in a background job. */
+  struct cmd_line_job* job;   /* The job being executed, NULL in the command line instance itself. */
+#endif
 };
 
+#if CMD_LINE_MAX_JOBS > 0
+/**
+ * Background job.
+ *
+ * The line and the arguments are copied, so the command line can receive next command
+ * while the job is running. The job has its own copy of the instance descriptor, which
+ * redirects all output of the command into the output buffer.
+ */
+struct cmd_line_job {
+  volatile int state;
+  volatile char cancel;
+  const cmd_desc_t* cmd;
+  int ret_val;
+  int argc;
+  char* arg_starts[CMD_LINE_JOB_MAX_ARGS];
+  char line_buf[CMD_LINE_MAX_CMD_LEN + 1];
+  char out_buf[CMD_LINE_JOB_OUT_BUF_LEN];
+  int out_len;
+  char truncated;
+  struct cmd_line_desc desc;
+};
+#endif
 
 /**
  * Command lines pool
  */
 struct cmd_lines_pool_st {
   struct cmd_line_desc cmd_lines_pool[CMD_LINES_MAX_CNT];
+#if CMD_LINE_MAX_JOBS > 0
+  struct cmd_line_job jobs_pool[CMD_LINES_MAX_CNT][CMD_LINE_MAX_JOBS];
+#endif
   uint8_t current_cmd_line;
 };
 
@@ -86,9 +120,7 @@ int rb_pop(cmd_line_desc_ptr_t cmd_line_desc, char* c) {
   return 0;
 }
 
-int cmd_line_printf_parse(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ...) {
-  va_list args;
-  va_start (args, format);
+int cmd_line_printf_parse(cmd_line_desc_ptr_t cmd_line_desc, const char *format, va_list args) {
   int ret_val = vsnprintf(cmd_line_desc->tx_buf, cmd_line_desc->tx_buf_len, format, args);
   if (ret_val < 0) {
       return CMD_LINE_PRINTF_ERR_PARSE;
@@ -96,10 +128,120 @@ int cmd_line_printf_parse(cmd_line_desc_ptr_t cmd_line_desc, const char *format,
   else if (ret_val > cmd_line_desc->tx_buf_len) {
       return CMD_LINE_PRINTF_ERR_LENGTH;
   }
-  va_end (args);
   return strlen(cmd_line_desc->tx_buf);
 }
 
+#if CMD_LINE_MAX_JOBS > 0
+/* Strips the trailing '&' from the line. Returns 1 if the line was marked to run in background. */
+int cmd_line_strip_background_mark(cmd_line_desc_ptr_t cmd_line_desc) {
+  int len = cmd_line_desc->line_buf_current;
+  if (len == 0 || cmd_line_desc->line_buf[len-1] != '&') {
+      return 0;
+  }
+  len--;
+  while (len > 0 && cmd_line_desc->line_buf[len-1] == ' ') {
+      len--;
+  }
+  cmd_line_desc->line_buf_current = len;
+  return 1;
+}
+
+int cmd_line_job_printf(struct cmd_line_job* job, const char *format, va_list args) {
+  int free_len = CMD_LINE_JOB_OUT_BUF_LEN - job->out_len;
+  int ret_val = vsnprintf(&job->out_buf[job->out_len], free_len, format, args);
+  if (ret_val < 0) {
+      return CMD_LINE_PRINTF_ERR_PARSE;
+  }
+  else if (ret_val >= free_len) {
+      job->out_len = CMD_LINE_JOB_OUT_BUF_LEN - 1;
+      job->truncated = 1;
+      return CMD_LINE_PRINTF_ERR_LENGTH;
+  }
+  job->out_len += ret_val;
+  return ret_val;
+}
+
+/* Worker entry, executed by the thread the job was handed over to. */
+static void cmd_line_job_run(void* arg) {
+  struct cmd_line_job* job = (struct cmd_line_job*)arg;
+  job->ret_val = job->cmd->cmd_fcn(job->argc, job->arg_starts, &job->desc);
+  CMD_LINE_MEM_BARRIER();
+  job->state = CMD_LINE_JOB_DONE;
+}
+
+int cmd_line_job_start(cmd_line_desc_ptr_t cmd_line_desc, const cmd_desc_t* cmd_ptr, int argc) {
+  struct cmd_line_job* job = NULL;
+  int i;
+  for (i = 0; i < CMD_LINE_MAX_JOBS; i++) {
+      if (cmd_line_desc->jobs[i].state == CMD_LINE_JOB_FREE) {
+          job = &cmd_line_desc->jobs[i];
+          break;
+      }
+  }
+  if (job == NULL) {
+      cmd_line_printf_tk(cmd_line_desc, "No free job slot.\r\n");
+      return CMD_LINE_ERR_OUT_OF_MEM;
+  }
+  if (argc >= CMD_LINE_JOB_MAX_ARGS) {
+      cmd_line_printf_tk(cmd_line_desc, "Too many arguments for a job.\r\n");
+      return CMD_LINE_ERR_OUT_OF_MEM;
+  }
+
+  int line_len = (cmd_line_desc->arg_starts[argc] - cmd_line_desc->line_buf) + strlen(cmd_line_desc->arg_starts[argc]);
+  if (line_len > CMD_LINE_MAX_CMD_LEN) {
+      cmd_line_printf_tk(cmd_line_desc, "Line too long for a job.\r\n");
+      return CMD_LINE_ERR_OUT_OF_MEM;
+  }
+  memcpy(job->line_buf, cmd_line_desc->line_buf, line_len + 1);
+  for (i = 0; i <= argc; i++) {
+      job->arg_starts[i] = &job->line_buf[cmd_line_desc->arg_starts[i] - cmd_line_desc->line_buf];
+  }
+
+  job->desc = *cmd_line_desc;
+  job->desc.jobs = NULL;
+  job->desc.job = job;
+  job->cmd = cmd_ptr;
+  job->argc = argc;
+  job->ret_val = CMD_LINE_SUCCESS;
+  job->out_len = 0;
+  job->out_buf[0] = '\0';
+  job->truncated = 0;
+  job->cancel = 0;
+  job->state = CMD_LINE_JOB_RUNNING;
+  CMD_LINE_MEM_BARRIER();
+
+  if (cmd_line_desc->job_spawn(&cmd_line_job_run, job) != CMD_LINE_SUCCESS) {
+      job->state = CMD_LINE_JOB_FREE;
+      cmd_line_printf_tk(cmd_line_desc, "Job not started.\r\n");
+      return CMD_LINE_ERR_GENERAL;
+  }
+  cmd_line_printf_tk(cmd_line_desc, "[%d] %s\r\n", (int)(job - cmd_line_desc->jobs) + 1, cmd_ptr->name);
+  return CMD_LINE_SUCCESS;
+}
+
+/* Prints the output of all finished jobs, each at once, and releases their slots. */
+void cmd_line_jobs_reap(cmd_line_desc_ptr_t cmd_line_desc) {
+  int i;
+  for (i = 0; i < CMD_LINE_MAX_JOBS; i++) {
+      struct cmd_line_job* job = &cmd_line_desc->jobs[i];
+      if (job->state != CMD_LINE_JOB_DONE) {
+          continue;
+      }
+      CMD_LINE_MEM_BARRIER();
+      if (job->out_len > 0) {
+          if (cmd_line_desc->uart_tx_tc(job->out_buf, job->out_len, cmd_line_desc->io_timeout_ms) != CMD_LINE_SUCCESS) {
+              cmd_line_desc->tx_err_cnt++;
+          }
+      }
+      if (job->truncated) {
+          cmd_line_printf_tk(cmd_line_desc, "\r\n[output truncated]\r\n");
+      }
+      cmd_line_printf_tk(cmd_line_desc, "[%d] %s (%d) %s\r\n", i + 1, job->ret_val == CMD_LINE_ERR_CANCELLED ? "Killed" : "Done", job->ret_val, job->cmd->name);
+      job->state = CMD_LINE_JOB_FREE;
+  }
+}
+#endif
+
 /* Public functions */
 const cmd_desc_t* cmd_line_find_command_by_name(const cmd_desc_t** cmd_line_root_list, const char* cmd_name, uint8_t indent_level) {
   if (cmd_name == NULL || cmd_line_root_list == NULL) {
@@ -164,12 +306,20 @@ cmd_line_desc_ptr_t cmd_line_init(const cmd_line_init_t* init) {
   cmd_line_desc->uart_rx_tc = init->rx_fn;
   cmd_line_desc->uart_tx_nb = init->tx_nb_fn;
   cmd_line_desc->uart_tx_tc = init->tx_tc_fn;
+#if CMD_LINE_MAX_JOBS > 0
+  cmd_line_desc->job_spawn = init->job_spawn_fn;
+  cmd_line_desc->jobs = cmd_lines_pool.jobs_pool[cmd_line_desc - cmd_lines_pool.cmd_lines_pool];
+  cmd_line_desc->job = NULL;
+#endif
 
   return cmd_line_desc;
 }
 
 int cmd_line_process(cmd_line_desc_ptr_t cmd_line_desc) {
   int retVal = CMD_LINE_NO_CMD;
+#if CMD_LINE_MAX_JOBS > 0
+  cmd_line_jobs_reap(cmd_line_desc);
+#endif
   int8_t c = cmd_line_getchar(cmd_line_desc);
   if (c == EOF) {
       return retVal;
@@ -192,6 +342,9 @@ int cmd_line_process(cmd_line_desc_ptr_t cmd_line_desc) {
       if (cmd_line_desc->echo_enabled) {
           cmd_line_printf_tk(cmd_line_desc, "%c", c, 1000);
       }
+#if CMD_LINE_MAX_JOBS > 0
+      int background = cmd_line_strip_background_mark(cmd_line_desc);
+#endif
       cmd_line_desc->line_buf[cmd_line_desc->line_buf_current] = '\0';
       int i;
       int argc = 0;
@@ -206,7 +359,19 @@ int cmd_line_process(cmd_line_desc_ptr_t cmd_line_desc) {
       cmd_line_desc->line_buf_current = 0;
       const cmd_desc_t* cmd_ptr = cmd_line_find_command_by_name(cmd_line_desc->cmd_line_root_list, cmd_line_desc->arg_starts[0], 0);
       if (cmd_ptr != NULL) {
+#if CMD_LINE_MAX_JOBS > 0
+          if ((background || cmd_ptr->async) && cmd_line_desc->job_spawn != NULL) {
+              retVal = cmd_line_job_start(cmd_line_desc, cmd_ptr, argc);
+          }
+          else {
+              if (background) {
+                  cmd_line_printf_tk(cmd_line_desc, "Background jobs not available, running inline.\r\n");
+              }
+              retVal = cmd_ptr->cmd_fcn(argc, cmd_line_desc->arg_starts, cmd_line_desc);
+          }
+#else
           retVal = cmd_ptr->cmd_fcn(argc, cmd_line_desc->arg_starts, cmd_line_desc);
+#endif
       }
       else {
           retVal =  CMD_LINE_ERR_CMD_NOT_FOUND;
@@ -221,7 +386,17 @@ const char* cmd_line_get_prompt(cmd_line_desc_ptr_t cmd_line_desc) {
 
 int cmd_line_printf(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ...) {
   /* FIXME: use ring buffer to add characters, otherwise they may be overwritten by next call. */
-  int str_len = cmd_line_printf_parse(cmd_line_desc, format);
+  va_list args;
+  va_start (args, format);
+#if CMD_LINE_MAX_JOBS > 0
+  if (cmd_line_desc->job != NULL) {
+      int ret_val = cmd_line_job_printf(cmd_line_desc->job, format, args);
+      va_end (args);
+      return ret_val;
+  }
+#endif
+  int str_len = cmd_line_printf_parse(cmd_line_desc, format, args);
+  va_end (args);
   if (str_len > 0) {
       if (cmd_line_desc->uart_tx_nb(cmd_line_desc->tx_buf, str_len) != CMD_LINE_SUCCESS) {
           cmd_line_desc->tx_err_cnt++;
@@ -232,7 +407,17 @@ int cmd_line_printf(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ...)
 }
 
 int cmd_line_printf_tk(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ...) {
-  int str_len = cmd_line_printf_parse(cmd_line_desc, format);
+  va_list args;
+  va_start (args, format);
+#if CMD_LINE_MAX_JOBS > 0
+  if (cmd_line_desc->job != NULL) {
+      int ret_val = cmd_line_job_printf(cmd_line_desc->job, format, args);
+      va_end (args);
+      return ret_val;
+  }
+#endif
+  int str_len = cmd_line_printf_parse(cmd_line_desc, format, args);
+  va_end (args);
   if (str_len > 0) {
       if (cmd_line_desc->uart_tx_tc(cmd_line_desc->tx_buf, str_len, 1000) != CMD_LINE_SUCCESS) {
           cmd_line_desc->tx_err_cnt++;
@@ -244,6 +429,11 @@ int cmd_line_printf_tk(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ..
 
 char cmd_line_getchar(cmd_line_desc_ptr_t cmd_line_desc) {
   char c;
+#if CMD_LINE_MAX_JOBS > 0
+  if (cmd_line_desc->job != NULL) {
+      return EOF;
+  }
+#endif
   if (rb_pop(cmd_line_desc, &c) < 0) {
       return EOF;
   }
@@ -252,6 +442,11 @@ char cmd_line_getchar(cmd_line_desc_ptr_t cmd_line_desc) {
 
 char cmd_line_getchar_tk(cmd_line_desc_ptr_t cmd_line_desc) {
   char c;
+#if CMD_LINE_MAX_JOBS > 0
+  if (cmd_line_desc->job != NULL) {
+      return EOF;
+  }
+#endif
   while (rb_pop(cmd_line_desc, &c) < 0) ;
   return c;
 }
@@ -265,3 +460,91 @@ void cmd_line_uart_rx_cb(cmd_line_desc_ptr_t cmd_line_desc, char c) {
       cmd_line_desc->rx_err_cnt++;
   }
 }
+
+#if CMD_LINE_MAX_JOBS > 0
+int cmd_line_job_state(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  if (cmd_line_desc->jobs == NULL || job_id < 1 || job_id > CMD_LINE_MAX_JOBS) {
+      return CMD_LINE_JOB_FREE;
+  }
+  return cmd_line_desc->jobs[job_id-1].state;
+}
+
+const char* cmd_line_job_name(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  if (cmd_line_job_state(cmd_line_desc, job_id) == CMD_LINE_JOB_FREE) {
+      return NULL;
+  }
+  return cmd_line_desc->jobs[job_id-1].cmd->name;
+}
+
+int cmd_line_job_wait(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  if (cmd_line_desc->jobs == NULL || job_id < 0 || job_id > CMD_LINE_MAX_JOBS) {
+      return CMD_LINE_ERR_GENERAL;
+  }
+
+  int yields;
+  for (yields = 0; 1; yields++) {
+      cmd_line_jobs_reap(cmd_line_desc);
+      int pending = 0;
+      int i;
+      for (i = 0; i < CMD_LINE_MAX_JOBS; i++) {
+          if ((job_id == 0 || job_id == i+1) && cmd_line_desc->jobs[i].state != CMD_LINE_JOB_FREE) {
+              pending = 1;
+          }
+      }
+      if (!pending) {
+          return CMD_LINE_SUCCESS;
+      }
+      /* Received characters stay in the buffer for cmd_line_process. */
+      if (cmd_line_desc->rx_buf_head != cmd_line_desc->rx_buf_tail) {
+          return CMD_LINE_ERR_INTERRUPTED;
+      }
+      if (yields >= CMD_LINE_JOB_WAIT_YIELDS) {
+          return CMD_LINE_ERR_TIMEOUT;
+      }
+      CMD_LINE_JOB_YIELD();
+  }
+}
+
+int cmd_line_job_kill(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  if (cmd_line_job_state(cmd_line_desc, job_id) != CMD_LINE_JOB_RUNNING) {
+      return CMD_LINE_ERR_GENERAL;
+  }
+  cmd_line_desc->jobs[job_id-1].cancel = 1;
+  return CMD_LINE_SUCCESS;
+}
+
+int cmd_line_job_cancelled(cmd_line_desc_ptr_t cmd_line_desc) {
+  if (cmd_line_desc->job == NULL) {
+      return 0;
+  }
+  return cmd_line_desc->job->cancel;
+}
+
+int cmd_line_is_job(cmd_line_desc_ptr_t cmd_line_desc) {
+  return cmd_line_desc->job != NULL;
+}
+#else
+int cmd_line_job_state(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  return CMD_LINE_JOB_FREE;
+}
+
+const char* cmd_line_job_name(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  return NULL;
+}
+
+int cmd_line_job_wait(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  return CMD_LINE_SUCCESS;
+}
+
+int cmd_line_job_kill(cmd_line_desc_ptr_t cmd_line_desc, int job_id) {
+  return CMD_LINE_ERR_GENERAL;
+}
+
+int cmd_line_job_cancelled(cmd_line_desc_ptr_t cmd_line_desc) {
+  return 0;
+}
+
+int cmd_line_is_job(cmd_line_desc_ptr_t cmd_line_desc) {
+  return 0;
+}
+#endif
@@ -44,6 +44,30 @@
 #define CMD_LINE_MAX_CMD_LEN               (32) /**< Maximal command line length. */
 #define CMD_LINE_MAX_INDENT                (5)  /**< Maximal sublists indentation. */
 #define CMD_LINES_MAX_CNT                  (2)  /**< Maximal number of command line instances. */
+#ifndef CMD_LINE_MAX_JOBS
+#define CMD_LINE_MAX_JOBS                  (0)  /**< Maximal number of background jobs per command line instance. 0 - background jobs are disabled. */
+#endif
+#ifndef CMD_LINE_JOB_MAX_ARGS
+#define CMD_LINE_JOB_MAX_ARGS              (4)  /**< Maximal number of arguments of a background job, including the command name. */
+#endif
+#ifndef CMD_LINE_JOB_OUT_BUF_LEN
+#define CMD_LINE_JOB_OUT_BUF_LEN           (512) /**< Size of the buffer capturing the output of one background job. Fits the output of all basic commands. */
+#endif
+#if CMD_LINE_MAX_JOBS > 0
+#ifndef CMD_LINE_MEM_BARRIER
+#if defined(__GNUC__)
+#define CMD_LINE_MEM_BARRIER()             __sync_synchronize() /**< Full memory barrier between the command line and worker threads. */
+#else
+#error "Define CMD_LINE_MEM_BARRIER() for your compiler, or set CMD_LINE_MAX_JOBS to 0."
+#endif
+#endif
+#ifndef CMD_LINE_JOB_YIELD
+#error "Define CMD_LINE_JOB_YIELD() to sleep for about 1 ms, e.g. osDelay(1), or set CMD_LINE_MAX_JOBS to 0."
+#endif
+#ifndef CMD_LINE_JOB_WAIT_YIELDS
+#define CMD_LINE_JOB_WAIT_YIELDS           (10000) /**< Maximal number of CMD_LINE_JOB_YIELD() calls while waiting for background jobs. */
+#endif
+#endif
 /**@}*/ // Cmd_Line_Lib_Config
 
 /*! \addtogroup Cmd_Line_Lib_Interface
@@ -59,11 +83,22 @@
 #define CMD_LINE_ERR_CMD_NOT_FOUND          (3) /**< Command not found. */
 #define CMD_LINE_NO_CMD                     (4) /**< No command to execute. */
 #define CMD_LINE_ERR_OUT_OF_MEM             (5) /**< Out of memory error. */
+#define CMD_LINE_ERR_TIMEOUT                (6) /**< Waiting timed out. */
+#define CMD_LINE_ERR_INTERRUPTED            (7) /**< Waiting interrupted by received character. */
+#define CMD_LINE_ERR_CANCELLED              (8) /**< Background job stopped on request, see @ref cmd_line_job_cancelled. */
 
 #define CMD_LINE_PRINTF_ERR_PARSE           (-1)  /**< IO function error - parsing parameters failed. */
 #define CMD_LINE_PRINTF_ERR_LENGTH          (-2)  /**< IO function error - buffer size exceeded. */
 /**@}*/ // Cmd_Line_Lib_Return_Values
 
+/*! \addtogroup Cmd_Line_Lib_Job_States Background job states
+*  @{
+*/
+#define CMD_LINE_JOB_FREE                   (0) /**< No job in the slot. */
+#define CMD_LINE_JOB_RUNNING                (1) /**< Job is being executed by a worker. */
+#define CMD_LINE_JOB_DONE                   (2) /**< Job has finished, its output was not flushed yet. */
+/**@}*/ // Cmd_Line_Lib_Job_States
+
 typedef struct cmd_line_desc* cmd_line_desc_ptr_t;  /**< Command line instance descriptor. */
 /**@}*/ // Cmd_Line_Lib_Interface
 
@@ -76,6 +111,8 @@ typedef struct cmd_line_desc* cmd_line_desc_ptr_t;  /**< Command line instance d
 typedef int (*uart_tx_nb_t)(const char*, int len);
 typedef int (*uart_tx_tc_t)(const char*, int len, int timeout_ms);
 typedef int (*uart_rx_tc_t)(cmd_line_desc_ptr_t cmd_line_desc, char*, int len, int timeout_ms);
+typedef void (*cmd_line_job_fcn_t)(void* job);
+typedef int (*job_spawn_t)(cmd_line_job_fcn_t job_fcn, void* job);
 /**@}*/ // Cmd_Line_Lib_Interface_Wrappers
 /**@}*/ // Cmd_Line_Lib_Interface
 
@@ -92,6 +129,7 @@ typedef struct cmd_desc_st {
   const char* one_line;     /**< Brief command description. Fits into one line. */
   const char* description;  /**< Detailed command description with syntax description and example. */
   cmd_do_fcn_t cmd_fcn;     /**< Command executive function. */
+  char async;               /**< 1 - Always run as a background job, 0 - run as a background job only when the line ends with '&'. */
 } cmd_desc_t;
 /**@}*/ // Cmd_Line_Lib_Cmd_Def
 
@@ -120,6 +158,7 @@ typedef struct cmd_line_init_st {
   char** args_starts;     /**< Buffer of pointers to beginnings of each argument.  Define in your program. */
   char echo_enabled;      /**< 1 - Echo received characters, 0 - no echo. */
   const cmd_desc_t** cmd_root_lis;  /**< Pointer to root command list. */
+  job_spawn_t job_spawn_fn; /**< Pointer to function handing a background job over to a worker thread. Can be NULL, then all commands run inline. */
 } cmd_line_init_t;
 
 /**
@@ -136,6 +175,8 @@ cmd_line_desc_ptr_t cmd_line_init(const cmd_line_init_t* init);
  * Command line processor main function.
  *
  * Call this function periodically, e.g. in your main application loop, to process received commands.
+ * Commands on a line ending with '&', or with @ref cmd_desc_st.async set, are handed over to
+ * @ref cmd_line_init_t.job_spawn_fn and the output of finished background jobs is printed here.
  *
  * @param [in] cmd_line_desc Command line instance descriptor.
  * @return  @ref CMD_LINE_SUCCESS if a command was successfully executed,
@@ -160,6 +201,7 @@ const char* cmd_line_get_prompt(cmd_line_desc_ptr_t cmd_line_desc);
  *
  * C stdio printf like function for printing formatted text to the command line output.
  * Returns immediately. All characters that will not fit into transmit buffer (@ref cmd_line_init_t.tx_buf) are discarded.
+ * In a background job, the output is captured and printed when the job finishes.
  *
  * @param [in] cmd_line_desc Command line instance descriptor.
  * @param [in] format printf like formatted string.
@@ -173,6 +215,7 @@ int cmd_line_printf(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ...);
  *
  * C stdio printf like function for printing formatted text to the command line output.
  * Blocks until all characters are printed.
+ * In a background job, the output is captured and printed when the job finishes.
  *
  * @param [in] cmd_line_desc Command line instance descriptor.
  * @param [in] format printf like formatted string.
@@ -187,7 +230,7 @@ int cmd_line_printf_tk(cmd_line_desc_ptr_t cmd_line_desc, const char *format, ..
  * Returns immediately.
  *
  * @param [in] cmd_line_desc Command line instance descriptor.
- * @return Received character if any, EOF if the receive buffer is empty.
+ * @return Received character if any, EOF if the receive buffer is empty or when called from a background job.
  */
 char cmd_line_getchar(cmd_line_desc_ptr_t cmd_line_desc);
 
@@ -197,7 +240,7 @@ char cmd_line_getchar(cmd_line_desc_ptr_t cmd_line_desc);
  * Waits for character reception if the receive buffer is empty.
  *
  * @param [in] cmd_line_desc Command line instance descriptor.
- * @return Received character.
+ * @return Received character, EOF when called from a background job.
  */
 char cmd_line_getchar_tk(cmd_line_desc_ptr_t cmd_line_desc);
 /**@}*/ // Cmd_Line_Lib_Public_IO_Funtions
@@ -230,6 +273,74 @@ void cmd_line_uart_rx_cb(cmd_line_desc_ptr_t cmd_line_desc, char c);
  * @return Pointer to the command descriptor, or NULL if no such command is defined.
  */
 const cmd_desc_t* cmd_line_find_command_by_name(const cmd_desc_t** cmd_line_root_list, const char* cmd_name, uint8_t indent_level);
+
+/*! \addtogroup Cmd_Line_Lib_Jobs Background jobs
+*  @{
+*/
+/**
+ * Get the state of a background job.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor.
+ * @param [in] job_id Job identifier, 1 to @ref CMD_LINE_MAX_JOBS.
+ * @return One of @ref Cmd_Line_Lib_Job_States, @ref CMD_LINE_JOB_FREE for invalid identifier.
+ */
+int cmd_line_job_state(cmd_line_desc_ptr_t cmd_line_desc, int job_id);
+
+/**
+ * Get the name of the command executed by a background job.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor.
+ * @param [in] job_id Job identifier, 1 to @ref CMD_LINE_MAX_JOBS.
+ * @return Command name, or NULL if there is no such job.
+ */
+const char* cmd_line_job_name(cmd_line_desc_ptr_t cmd_line_desc, int job_id);
+
+/**
+ * Wait for background jobs to finish.
+ *
+ * Blocks until the job finishes, flushing the output of all finished jobs meanwhile.
+ * Calls CMD_LINE_JOB_YIELD() between checks and returns early when a character is received,
+ * so the user can type another command, e.g. kill, or after @ref CMD_LINE_JOB_WAIT_YIELDS calls.
+ * Must not be called from a background job.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor.
+ * @param [in] job_id Job identifier, 1 to @ref CMD_LINE_MAX_JOBS, or 0 to wait for all jobs.
+ * @return @ref CMD_LINE_SUCCESS, @ref CMD_LINE_ERR_INTERRUPTED, @ref CMD_LINE_ERR_TIMEOUT,
+ *         or @ref CMD_LINE_ERR_GENERAL for invalid identifier.
+ */
+int cmd_line_job_wait(cmd_line_desc_ptr_t cmd_line_desc, int job_id);
+
+/**
+ * Request a background job to stop.
+ *
+ * The request is cooperative, the command has to poll @ref cmd_line_job_cancelled and return
+ * @ref CMD_LINE_ERR_CANCELLED. The job is then reported as killed, otherwise as done.
+ * Must not be called from a background job.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor.
+ * @param [in] job_id Job identifier, 1 to @ref CMD_LINE_MAX_JOBS.
+ * @return @ref CMD_LINE_SUCCESS, or @ref CMD_LINE_ERR_GENERAL if no such job is running.
+ */
+int cmd_line_job_kill(cmd_line_desc_ptr_t cmd_line_desc, int job_id);
+
+/**
+ * Check whether the current background job was requested to stop.
+ *
+ * Call this periodically from long running commands and return @ref CMD_LINE_ERR_CANCELLED when set.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor passed to the command function.
+ * @return 1 if the command should return as soon as possible, 0 otherwise.
+ */
+int cmd_line_job_cancelled(cmd_line_desc_ptr_t cmd_line_desc);
+
+/**
+ * Check whether the command is executed as a background job.
+ *
+ * @param [in] cmd_line_desc Command line instance descriptor passed to the command function.
+ * @return 1 in a background job, 0 otherwise.
+ */
+int cmd_line_is_job(cmd_line_desc_ptr_t cmd_line_desc);
+/**@}*/ // Cmd_Line_Lib_Jobs
 /**@}*/ // Cmd_Line_Lib_Interface
 
 #endif /* CMDLINE_H_ */